@@ -0,0 +1,336 @@
+//
+// Created by timob on 18.10.2026.
+//
+
+#ifndef SPACEMACHINE_COROUTINESPACEMACHINE_HPP
+#define SPACEMACHINE_COROUTINESPACEMACHINE_HPP
+
+// Coroutine states need C++20. Under older standards this header is empty so
+// it can be included unconditionally.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define SPACEMACHINE_COROUTINES 1
+
+#include "SpaceMachine.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SpaceMachine {
+
+template<std::size_t, std::size_t, std::size_t>
+class CoroutineStateMachineBuilder;
+
+constexpr std::size_t FRAME_ARENA_SIZE = 1024;
+
+// Stack allocator for coroutine frames living inside a state machine.
+// Frames are freed in LIFO order in practice (a state's work is destroyed
+// before the next one is created), so a bump pointer is enough. Out of order
+// frees are tolerated and the arena rewinds once no frame is alive.
+class FrameArena {
+public:
+    static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+    // Makes an arena the one new frames on this thread are allocated from
+    class Scope {
+    public:
+        Scope() = delete;
+        explicit Scope(FrameArena& arena) noexcept
+            : previous(std::exchange(active, &arena))
+        {}
+        ~Scope() { active = previous; }
+        Scope(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+    private:
+        FrameArena* previous;
+    };
+
+    FrameArena() = delete;
+    FrameArena(std::byte* buffer, const std::size_t capacity) noexcept
+        : buffer(buffer), capacity(capacity)
+    {}
+    ~FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena(FrameArena&&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    FrameArena& operator=(FrameArena&&) = delete;
+
+    // Every frame is prefixed with a pointer to its arena, so it can be freed
+    // even when a different arena (or none) is active.
+    static void* allocateFrame(const std::size_t size)
+    {
+        if (active == nullptr) {
+            throw std::logic_error(
+                    "No frame arena is active! Task coroutines can only be "
+                    "started as the work of a CoroutineStateMachine.");
+        }
+        std::byte* block = active->allocate(FRAME_HEADER_SIZE + size);
+        std::memcpy(block, &active, sizeof(active));
+        return block + FRAME_HEADER_SIZE;
+    }
+
+    static void deallocateFrame(void* frame, const std::size_t size) noexcept
+    {
+        std::byte* block = static_cast<std::byte*>(frame) - FRAME_HEADER_SIZE;
+        FrameArena* arena = nullptr;
+        std::memcpy(&arena, block, sizeof(arena));
+        arena->deallocate(block, FRAME_HEADER_SIZE + size);
+    }
+
+private:
+    static constexpr std::size_t alignUp(const std::size_t size) noexcept
+    {
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // Keeps the frame behind the header aligned
+    static constexpr std::size_t FRAME_HEADER_SIZE = ALIGNMENT;
+    static_assert(sizeof(FrameArena*) <= FRAME_HEADER_SIZE);
+
+    std::byte* allocate(const std::size_t size)
+    {
+        const std::size_t alignedSize = alignUp(size);
+        if (alignedSize > capacity - top) {
+            throw std::range_error(
+                    "Coroutine frame does not fit into the frame arena!\n"
+                    "Bytes reserved: "
+                    + std::to_string(capacity)
+                    + "\n"
+                      "Bytes in use: "
+                    + std::to_string(top)
+                    + "\n"
+                      "Bytes requested: "
+                    + std::to_string(alignedSize)
+                    + "\n"
+                      "Try allocating a bigger state machine, like:\n"
+                      "CoroutineStateMachine<MaxNumStates, "
+                      "MaxNumTransitions, "
+                    + std::to_string(top + alignedSize) + ">\n");
+        }
+        std::byte* block = buffer + top;
+        top += alignedSize;
+        ++numFrames;
+        return block;
+    }
+
+    void deallocate(std::byte* block, const std::size_t size) noexcept
+    {
+        --numFrames;
+        if (numFrames == 0) {
+            top = 0;
+            return;
+        }
+        if (block + alignUp(size) == buffer + top)
+            top = static_cast<std::size_t>(block - buffer);
+    }
+
+    static inline thread_local FrameArena* active = nullptr;
+    std::byte* buffer;
+    std::size_t capacity;
+    std::size_t top = 0;
+    std::size_t numFrames = 0;
+};
+
+// Return type of a coroutine state's work. Frames are placed in the arena of
+// the state machine running the work instead of on the heap, including the
+// frames of coroutines started from within the work.
+class Task {
+public:
+    struct promise_type {
+        std::exception_ptr exception;
+
+        Task get_return_object() noexcept
+        {
+            return Task{
+                    std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept
+        {
+            exception = std::current_exception();
+        }
+
+        static void* operator new(const std::size_t size)
+        {
+            return FrameArena::allocateFrame(size);
+        }
+        static void operator delete(void* frame,
+                                    const std::size_t size) noexcept
+        {
+            FrameArena::deallocateFrame(frame, size);
+        }
+    };
+
+    Task() = default;
+    ~Task()
+    {
+        if (handle) handle.destroy();
+    }
+    Task(const Task&) = delete;
+    Task(Task&& other) noexcept: handle(std::exchange(other.handle, {})) {}
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this == &other) return *this;
+        if (handle) handle.destroy();
+        handle = std::exchange(other.handle, {});
+        return *this;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(handle);
+    }
+    bool done() const { return handle.done(); }
+    void resume() const { handle.resume(); }
+
+    void rethrowIfFailed() const
+    {
+        if (handle.promise().exception)
+            std::rethrow_exception(handle.promise().exception);
+    }
+
+private:
+    explicit Task(const std::coroutine_handle<promise_type> handle) noexcept
+        : handle(handle)
+    {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// co_await nextTick(); hands control back to run() and continues from here on
+// the next tick, unless a transition left the state in the meantime.
+constexpr std::suspend_always nextTick() noexcept { return {}; }
+
+// State machine whose states' work is a coroutine that may span several
+// ticks. The work is started on the first tick in a state, resumed on every
+// following tick and restarted on the tick after it finishes. Any transition
+// cancels it by destroying its frame.
+template<std::size_t MaxNumStates = MAX_NUM_STATES,
+         std::size_t MaxNumTransitions = MAX_NUM_TRANSITIONS,
+         std::size_t FrameArenaSize = FRAME_ARENA_SIZE>
+class CoroutineStateMachine {
+    using StateMachineType = StateMachine<MaxNumStates, MaxNumTransitions>;
+
+public:
+    using StateIndex = typename StateMachineType::StateIndex;
+    using TransitionIndex = typename StateMachineType::TransitionIndex;
+
+    CoroutineStateMachine() = default;
+    ~CoroutineStateMachine() = default;
+    // Suspended frames live inside the machine, so it must stay in place
+    CoroutineStateMachine(const CoroutineStateMachine&) = delete;
+    CoroutineStateMachine(CoroutineStateMachine&&) = delete;
+    CoroutineStateMachine& operator=(const CoroutineStateMachine&) = delete;
+    CoroutineStateMachine& operator=(CoroutineStateMachine&&) = delete;
+
+    void doWork() { stateMachine.doWork(); }
+
+    bool triggerTransitions()
+    {
+        if (!stateMachine.triggerTransitions()) return false;
+        work = Task{};
+        return true;
+    }
+
+    void run()
+    {
+        triggerTransitions();
+        doWork();
+    }
+
+private:
+    void resumeWork(const StateIndex stateIndex)
+    {
+        const FrameArena::Scope scope(frameArena);
+        if (!work) work = works[stateIndex]();
+        work.resume();
+        if (!work.done()) return;
+        const Task finished = std::move(work);
+        finished.rethrowIfFailed();
+    }
+
+    friend class CoroutineStateMachineBuilder<MaxNumStates, MaxNumTransitions,
+                                              FrameArenaSize>;
+    StateMachineType stateMachine;
+    std::function<Task()> works[MaxNumStates];
+    alignas(FrameArena::ALIGNMENT) std::byte frameStorage[FrameArenaSize];
+    FrameArena frameArena{frameStorage, FrameArenaSize};
+    // Declared last so the frame is destroyed before the arena it lives in
+    Task work;
+};
+
+template<std::size_t MaxNumStates = MAX_NUM_STATES,
+         std::size_t MaxNumTransitions = MAX_NUM_TRANSITIONS,
+         std::size_t FrameArenaSize = FRAME_ARENA_SIZE>
+class CoroutineStateMachineBuilder {
+    using StateMachineType = CoroutineStateMachine<MaxNumStates,
+                                                   MaxNumTransitions,
+                                                   FrameArenaSize>;
+    using BuilderType = StateMachineBuilder<MaxNumStates, MaxNumTransitions>;
+    using StateIndex = typename StateMachineType::StateIndex;
+
+public:
+    using State = typename BuilderType::State;
+    using Transition = typename BuilderType::Transition;
+
+    CoroutineStateMachineBuilder() = delete;
+    explicit CoroutineStateMachineBuilder(StateMachineType& stateMachine)
+        : stateMachine(stateMachine), builder(stateMachine.stateMachine)
+    {
+        works.reserve(MaxNumStates);
+    }
+    ~CoroutineStateMachineBuilder() = default;
+    CoroutineStateMachineBuilder(const CoroutineStateMachineBuilder&) = default;
+    CoroutineStateMachineBuilder(CoroutineStateMachineBuilder&&) = default;
+    CoroutineStateMachineBuilder& operator=(const CoroutineStateMachineBuilder&)
+            = default;
+    CoroutineStateMachineBuilder& operator=(CoroutineStateMachineBuilder&&)
+            = default;
+
+    const State& createState(std::function<Task()> work)
+    {
+        const auto stateIndex = static_cast<StateIndex>(works.size());
+        works.push_back(std::move(work));
+        return builder.createState([&machine = stateMachine, stateIndex]() {
+            machine.resumeWork(stateIndex);
+        });
+    }
+
+    void setInitialState(const State& state) { builder.setInitialState(state); }
+
+    const Transition& createTransition(const State& from, const State& to,
+                                       std::function<bool()> condition)
+    {
+        return builder.createTransition(from, to, std::move(condition));
+    }
+
+    StateMachineType& build()
+    {
+        builder.build();
+        for (std::size_t i = 0; i < works.size(); ++i)
+            stateMachine.works[i] = std::move(works[i]);
+        return stateMachine;
+    }
+
+private:
+    StateMachineType& stateMachine;
+    BuilderType builder;
+    std::vector<std::function<Task()>> works;
+};
+
+} // namespace SpaceMachine
+
+#endif // defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#endif // SPACEMACHINE_COROUTINESPACEMACHINE_HPP
@@ -1,3 +1,4 @@
+#include "include/spacemachine/CoroutineSpaceMachine.hpp"
 #include "include/spacemachine/SpaceMachine.hpp"
 #include "include/spacemachine/TemplateSpaceMachine.hpp"
 #include <iostream>
@@ -72,9 +73,40 @@ void testCompileTimeStateMachine()
     s3.work();
 }
 
+#ifdef SPACEMACHINE_COROUTINES
+void testCoroutineStateMachine()
+{
+    using namespace SpaceMachine;
+    alignas(64) static CoroutineStateMachine stateMachine;
+    int ticks = 0;
+    {
+        CoroutineStateMachineBuilder builder(stateMachine);
+        const auto& load = builder.createState([]() -> Task {
+            for (int step = 1; step <= 5; ++step) {
+                std::cout << "Loading step " << step << std::endl;
+                co_await nextTick();
+            }
+        });
+        const auto& idle = builder.createState([]() -> Task {
+            std::cout << "Idle" << std::endl;
+            co_return;
+        });
+        builder.createTransition(load, idle, [&] { return ticks == 3; });
+        builder.createTransition(idle, load, [&] { return ticks == 5; });
+        builder.setInitialState(load);
+        builder.build();
+    }
+
+    for (; ticks < 10; ++ticks) stateMachine.run();
+}
+#endif
+
 int main()
 {
     testCompileTimeStateMachine();
+#ifdef SPACEMACHINE_COROUTINES
+    testCoroutineStateMachine();
+#endif
     // testRuntimeStateMachine();
     return 0;
 }